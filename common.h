@@ -7,13 +7,20 @@
 #include <git2.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 typedef enum {
     NORMAL =   (1 << 0),
     GIT_MENU = (1 << 1),
-    DEBUG_NEIGHBOURS = (1 << 2)
+    DEBUG_NEIGHBOURS = (1 << 2),
+    CYCLE_STOP = (1 << 3),
+    BLOCKED_STEP = (1 << 4)
 } game_flags_t;
 
+/* Number of past generations whose board hash we remember. Cycles with a period
+   shorter than this get detected. */
+#define HISTORY_SIZE 64
+
 /* Our own commit representation for comfier displaying. The only info we really
    need is the commit OID. */
 
@@ -31,7 +38,106 @@ struct commit_node_t {
     char oid_as_string[41]; // 20 oid Bytes * 2 chars to represent each byte + terminating \0
 };
 
+/* Lightweight instrumentation of the hot paths. Every timed phase pushes an event
+   into a ring buffer and updates its running stats. Slots are claimed with an atomic
+   increment, so writers never wait on readers (the overlay or the trace exporter). */
+
+typedef enum {
+    PROFILE_GAME_UPDATE,
+    PROFILE_GAME_RENDER,
+    PROFILE_DUMP_GIT_TREE,
+    PROFILE_MAKE,
+    PROFILE_LOAD_FUNCTIONS,
+    PROFILE_PHASE_COUNT
+} profile_phase_t;
+
+static const char *const profile_phase_names[PROFILE_PHASE_COUNT] __attribute__((unused)) = {
+    "game_update",
+    "game_render",
+    "dump_git_tree",
+    "make",
+    "load_functions"
+};
+
+#define PROFILE_RING_SIZE 4096 // must be a power of two
+#define PROFILE_BUCKETS 32     // bucket i counts durations in [2^i, 2^(i+1)) ns
+
+typedef struct {
+    uint32_t phase;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+} profile_event_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t last_ns;
+    uint64_t histogram[PROFILE_BUCKETS];
+} profile_phase_stats_t;
+
 typedef struct {
+    int32_t enabled;
+    uint64_t ring_head; // number of events ever written
+    profile_event_t ring[PROFILE_RING_SIZE];
+    profile_phase_stats_t phases[PROFILE_PHASE_COUNT];
+} profile_t;
+
+static inline uint64_t profile_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Returns 0 when profiling is off so that profile_end() becomes a no-op
+static inline uint64_t profile_begin(profile_t *p)
+{
+    return (p && __atomic_load_n(&p->enabled, __ATOMIC_RELAXED)) ? profile_now() : 0;
+}
+
+static inline void profile_end(profile_t *p, profile_phase_t phase, uint64_t start)
+{
+    if (!start)
+        return;
+
+    uint64_t duration = profile_now() - start;
+
+    uint64_t slot = __atomic_fetch_add(&p->ring_head, 1, __ATOMIC_RELAXED) & (PROFILE_RING_SIZE - 1);
+    p->ring[slot].phase = phase;
+    p->ring[slot].start_ns = start;
+    p->ring[slot].duration_ns = duration;
+
+    profile_phase_stats_t *stats = &p->phases[phase];
+    __atomic_fetch_add(&stats->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->total_ns, duration, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->last_ns, duration, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&stats->max_ns, __ATOMIC_RELAXED);
+    while (duration > max && !__atomic_compare_exchange_n(&stats->max_ns, &max, duration, 1,
+                                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    int bucket = duration ? 63 - __builtin_clzll(duration) : 0;
+    if (bucket >= PROFILE_BUCKETS)
+        bucket = PROFILE_BUCKETS - 1;
+    __atomic_fetch_add(&stats->histogram[bucket], 1, __ATOMIC_RELAXED);
+}
+
+/* Lets the platform layer take over stepping, e.g. to spread the board across worker
+   processes. It advances g->board by the given number of generations and fills the
+   hash and population of each one.
+
+   Returns 1 on success. On failure it returns 0 with g->board untouched and clears
+   g->platform_step, so the game can compute the generations itself. */
+
+struct game_state_t;
+typedef struct game_state_t game_state_t;
+
+#define PLATFORM_STEP(funcname) int funcname(game_state_t *g, int generations, uint64_t *hashes, uint64_t *populations)
+typedef PLATFORM_STEP(platform_step_f);
+
+struct game_state_t {
     int32_t input;
     int32_t height;
     int32_t width;
@@ -50,10 +156,77 @@ typedef struct {
 
     char inputfield[32];
     size_t inputn;    
-} game_state_t;
+
+    /* Fields below were added after the ones above, which must keep their offsets so
+       game.so builds from older commits can still be hot-loaded */
+    uint64_t generation;
+    uint64_t population;
+    int32_t period;                        // 0 until a cycle has been detected
+    uint64_t hash_history[HISTORY_SIZE];   // board hashes, indexed by generation % HISTORY_SIZE
+
+    profile_t *profile;
+
+    platform_step_f *platform_step; // NULL unless the platform layer steps the board itself
+
+    uint64_t jump_target;           // generation a pending 'j' jump is heading to, 0 if none
+    uint64_t history_start;         // first generation with a valid entry in hash_history
+};
+
+/* Zobrist-like hash of a single live cell. The board hash is the XOR of the hashes
+   of all its live cells, so it can be built cell by cell while stepping. */
+static inline uint64_t cell_hash(uint64_t index)
+{
+    uint64_t z = index + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* Forgets any detected cycle and restarts the hash history from the current board,
+   keeping the generation count. Needed whenever the board changes by other means
+   than the stepper, e.g. a reset or code that steps with different rules after a
+   hot reload. Also cancels a pending jump. */
+static inline void reset_generation_tracking(game_state_t *g)
+{
+    uint64_t hash = 0;
+    uint64_t population = 0;
+    for (int i = 0; i < g->height*g->width; ++i)
+    {
+        if (g->board[i] == 'X')
+        {
+            hash ^= cell_hash(i);
+            ++population;
+        }
+    }
+
+    g->population = population;
+    g->period = 0;
+    g->jump_target = 0;
+    g->history_start = g->generation;
+    for (int i = 0; i < HISTORY_SIZE; ++i)
+        g->hash_history[i] = 0;
+    g->hash_history[g->generation % HISTORY_SIZE] = hash;
+}
 
 git_oid empty_oid = { .id = {} };
 
+/* Board published in shared memory for read-only viewers. The writer bumps sequence
+   to an odd value before copying a new board in and to the next even value after,
+   so readers can tell a torn copy apart and retry without ever blocking it. */
+
+#define SHARED_BOARD_NAME "/runtime-git-board"
+#define SHARED_BOARD_MAGIC 0x52474231 // "RGB1"
+
+typedef struct {
+    uint32_t magic;
+    int32_t height;
+    int32_t width;
+    uint64_t sequence;
+    uint64_t generation;
+    uint64_t population;
+    uint8_t board[];
+} shared_board_t;
+
 
 
 #define GAME_UPDATE(funcname) void funcname(game_state_t *g)
@@ -65,12 +238,22 @@ typedef GAME_RESET(game_reset_f);
 #define GAME_RENDER(funcname) void funcname(game_state_t *g)
 typedef GAME_RENDER(game_render_f);
 
+/* Computes the next generation of a slab of rows. in holds rows+2 rows: a halo row
+   above the slab, the slab itself and a halo row below. Halo rows outside the board
+   are flagged by has_above/has_below. Hash and population of the new rows are
+   added to *hash and *population. */
+#define GAME_STEP_SLAB(funcname) void funcname(uint8_t *out, const uint8_t *in, int rows, int width, \
+                                               int has_above, int has_below, uint64_t first_index, \
+                                               uint64_t *hash, uint64_t *population)
+typedef GAME_STEP_SLAB(game_step_slab_f);
+
 
 
 typedef struct {
     game_update_f *game_update;
     game_reset_f *game_reset;
     game_render_f *game_render;
+    game_step_slab_f *game_step_slab;
 } game_code_t;
 
 game_code_t game_code;
@@ -0,0 +1 @@
+int wclear(){return 0;} int wmove(){return 0;} int wprintw(){return 0;} int mvwprintw(){return 0;} int wattrset(){return 0;} int wattroff(){return 0;} int wborder(){return 0;} int waddch(){return 0;} int getmaxy(){return 0;} int getmaxx(){return 0;} int getcury(){return 0;} int getcurx(){return 0;}
@@ -31,13 +31,308 @@ int count_neighbours(int x, int y, uint8_t *board, int width, int height)
     return count;
 }
 
+/* Stores the hash of a freshly computed generation and looks for the same board
+   in the history table. A match P generations back means we are in a period-P cycle. */
+static void record_generation(game_state_t *g, uint64_t hash, uint64_t population)
+{
+    ++g->generation;
+    g->population = population;
+    g->hash_history[g->generation % HISTORY_SIZE] = hash;
+
+    if (g->period)
+        return;
+
+    for (uint64_t p = 1; p < HISTORY_SIZE && p <= g->generation - g->history_start; ++p)
+    {
+        if (g->hash_history[(g->generation - p) % HISTORY_SIZE] == hash)
+        {
+            g->period = p;
+            break;
+        }
+    }
+}
+
+static void step(game_state_t *g)
+{
+    uint64_t hash = 0;
+    uint64_t population = 0;
+
+    for (int i = 0; i < g->height; ++i)
+        for (int j = 0; j < g->width; ++j)
+        {
+            int neighbours = count_neighbours(j, i, g->board, g->width, g->height);
+            if (g->board[i*g->width+j] == 'X') // currently alive
+            {
+                if (neighbours == 2 || neighbours == 3)
+                {
+                    // Live
+                    g->aux_board[i*g->width+j] = 'X';
+                    hash ^= cell_hash(i*g->width+j);
+                    ++population;
+                }
+                else
+                {
+                    // Die
+                    g->aux_board[i*g->width+j] = ' ';
+                }
+            }
+            else
+            {
+                // Currently dead
+                if (neighbours == 3)
+                {
+                    // Live
+                    g->aux_board[i*g->width+j] = 'X';
+                    hash ^= cell_hash(i*g->width+j);
+                    ++population;
+                }
+                else
+                {
+                    // Die
+                    g->aux_board[i*g->width+j] = ' ';
+                }
+            }
+        }
+    memcpy(g->board, g->aux_board, g->width*g->height);
+
+    record_generation(g, hash, population);
+}
+
+/* Temporal blocking: the board is cut in bands of full rows, and each band is
+   advanced several generations in a row while it stays in cache. A band reads a
+   halo of as many extra rows as generations it computes, and the valid region
+   shrinks by one row per side on each generation. */
+
+#define BLOCK_GENERATIONS 8
+#define BLOCK_BYTES (128*1024) // per scratch buffer, two of them should fit in L2
+
+/* Computes one row of the next generation. above/below are NULL outside the board.
+   Neighbour counting has to match count_neighbours() cell for cell, including
+   its use of the first cell of the row below rather than the one under x. */
+static void step_row(uint8_t *out, const uint8_t *above, const uint8_t *row, const uint8_t *below,
+                     int width, uint64_t first_index, uint64_t *hash, uint64_t *population)
+{
+    for (int x = 0; x < width; ++x)
+    {
+        int neighbours = 0;
+
+        if (above)
+        {
+            neighbours += (x-1 >= 0) && above[x-1] == 'X';
+            neighbours += above[x] == 'X';
+            neighbours += (x+1 < width) && above[x+1] == 'X';
+        }
+
+        neighbours += (x-1 >= 0) && row[x-1] == 'X';
+        neighbours += (x+1 < width) && row[x+1] == 'X';
+
+        if (below)
+        {
+            neighbours += (x-1 >= 0) && below[x-1] == 'X';
+            neighbours += below[0] == 'X';
+            neighbours += (x+1 < width) && below[x+1] == 'X';
+        }
+
+        if (neighbours == 3 || (neighbours == 2 && row[x] == 'X'))
+        {
+            out[x] = 'X';
+            *hash ^= cell_hash(first_index + x);
+            ++*population;
+        }
+        else
+        {
+            out[x] = ' ';
+        }
+    }
+}
+
+/* Advances the board by up to BLOCK_GENERATIONS generations in a single pass over
+   memory. Hash and population of every intermediate generation are returned so
+   that cycle detection sees each of them.
+
+   Returns 1 on success, 0 if the scratch buffers could not be allocated, in which
+   case the board is left untouched */
+static int step_blocked(game_state_t *g, int generations, uint64_t *hashes, uint64_t *populations)
+{
+    int width = g->width;
+    int height = g->height;
+    int k = generations;
+
+    /* Halo rows get recomputed by both neighbouring bands, so on very wide boards we
+       give up on fitting in L2 rather than letting the redundant work dominate */
+    int band = BLOCK_BYTES / width - 2*k;
+    if (band < 8*k)
+        band = 8*k;
+
+    for (int t = 0; t < k; ++t)
+    {
+        hashes[t] = 0;
+        populations[t] = 0;
+    }
+
+    uint8_t *src_buffer = NULL;
+    uint8_t *dst_buffer = NULL;
+    if (k > 1)
+    {
+        src_buffer = (uint8_t *) malloc((size_t)(band + 2*k) * width);
+        dst_buffer = (uint8_t *) malloc((size_t)(band + 2*k) * width);
+        if (!src_buffer || !dst_buffer)
+        {
+            free(src_buffer);
+            free(dst_buffer);
+            return 0;
+        }
+    }
+
+    for (int r0 = 0; r0 < height; r0 += band)
+    {
+        int r1 = r0 + band < height ? r0 + band : height;
+        int lo = r0 - k > 0 ? r0 - k : 0;
+
+        // The first generation reads straight from the board, the last one writes straight to aux_board
+        const uint8_t *src = g->board;
+        int src_origin = 0;
+
+        for (int t = 1; t <= k; ++t)
+        {
+            int from = r0 - (k - t) > 0 ? r0 - (k - t) : 0;
+            int to = r1 + (k - t) < height ? r1 + (k - t) : height;
+
+            uint8_t *dst = t == k ? g->aux_board : dst_buffer;
+            int dst_origin = t == k ? 0 : lo;
+
+            for (int y = from; y < to; ++y)
+            {
+                uint64_t hash = 0;
+                uint64_t population = 0;
+
+                step_row(dst + (size_t)(y - dst_origin) * width,
+                         y-1 >= 0 ? src + (size_t)(y-1 - src_origin) * width : NULL,
+                         src + (size_t)(y - src_origin) * width,
+                         y+1 < height ? src + (size_t)(y+1 - src_origin) * width : NULL,
+                         width, (uint64_t)y * width, &hash, &population);
+
+                // Only the rows this band owns count towards the board totals
+                if (y >= r0 && y < r1)
+                {
+                    hashes[t-1] ^= hash;
+                    populations[t-1] += population;
+                }
+            }
+
+            if (t < k)
+            {
+                src = dst_buffer;
+                src_origin = lo;
+                uint8_t *swap = src_buffer;
+                src_buffer = dst_buffer;
+                dst_buffer = swap;
+            }
+        }
+    }
+
+    free(src_buffer);
+    free(dst_buffer);
+
+    memcpy(g->board, g->aux_board, width*height);
+    return 1;
+}
+
+static void advance(game_state_t *g, uint64_t generations)
+{
+    if (!(g->flags & BLOCKED_STEP) && !g->platform_step)
+    {
+        for (uint64_t i = 0; i < generations; ++i)
+            step(g);
+        return;
+    }
+
+    uint64_t hashes[BLOCK_GENERATIONS];
+    uint64_t populations[BLOCK_GENERATIONS];
+    while (generations)
+    {
+        int k = generations < BLOCK_GENERATIONS ? generations : BLOCK_GENERATIONS;
+        int stepped = g->platform_step && g->platform_step(g, k, hashes, populations);
+        if (!stepped && g->flags & BLOCKED_STEP)
+            stepped = step_blocked(g, k, hashes, populations);
+
+        if (stepped)
+        {
+            for (int t = 0; t < k; ++t)
+                record_generation(g, hashes[t], populations[t]);
+        }
+        else
+        {
+            // Reference stepper, also the fallback when the others fail
+            for (int t = 0; t < k; ++t)
+                step(g);
+        }
+        generations -= k;
+    }
+}
+
+/* Time we may spend on a jump per call before handing control back to the platform
+   layer, which keeps calling us every frame while jump_target is set */
+#define JUMP_BUDGET_NS (30*1000*1000)
+
+/* Advances the simulation towards g->jump_target. Once a cycle is known we only
+   step the remainder modulo the period and move the history table along with us.
+   Without a cycle we may need many calls to get there, one per frame. */
+static void continue_jump(game_state_t *g)
+{
+    uint64_t target = g->jump_target;
+    uint64_t deadline = profile_now() + JUMP_BUDGET_NS;
+
+    while (g->generation < target && !g->period)
+    {
+        uint64_t left = target - g->generation;
+        int batched = g->flags & BLOCKED_STEP || g->platform_step;
+        advance(g, batched && left > BLOCK_GENERATIONS ? BLOCK_GENERATIONS : 1);
+
+        if (profile_now() > deadline)
+            return;
+    }
+
+    g->jump_target = 0;
+
+    if (g->generation >= target)
+        return;
+
+    advance(g, (target - g->generation) % g->period);
+
+    uint64_t history[HISTORY_SIZE];
+    for (int i = 0; i < HISTORY_SIZE; ++i)
+        history[i] = g->hash_history[(g->generation - i) % HISTORY_SIZE];
+    for (int i = 0; i < HISTORY_SIZE; ++i)
+        g->hash_history[(target - i) % HISTORY_SIZE] = history[i];
+
+    uint64_t known = g->generation - g->history_start;
+    if (known > HISTORY_SIZE - 1)
+        known = HISTORY_SIZE - 1;
+    g->history_start = target - known;
+    g->generation = target;
+}
+
+GAME_STEP_SLAB(game_step_slab)
+{
+    for (int y = 0; y < rows; ++y)
+    {
+        step_row(out + (size_t)y * width,
+                 y > 0 || has_above ? in + (size_t)y * width : NULL,
+                 in + (size_t)(y+1) * width,
+                 y < rows-1 || has_below ? in + (size_t)(y+2) * width : NULL,
+                 width, first_index + (uint64_t)y * width, hash, population);
+    }
+}
+
 GAME_UPDATE(game_update)
 {
     /* Input handling */
     switch (g->input)
     {
     case 'g': // open/close the git menu
-        g->flags = g->flags & GIT_MENU ? NORMAL : GIT_MENU;
+        // Swap views but keep mode bits such as CYCLE_STOP
+        g->flags = (g->flags & ~(NORMAL | GIT_MENU)) | (g->flags & GIT_MENU ? NORMAL : GIT_MENU);
         // in any case, clean input fields
         g->inputn = 0;
         for (size_t i = 0; i < sizeof(g->inputfield); ++i)
@@ -45,6 +340,48 @@ GAME_UPDATE(game_update)
         return;
         break;
     case 'n': // advance the simulation
+        // Once a cycle is found there is nothing new to compute if the user asked us to stop
+        if (g->flags & CYCLE_STOP && g->period)
+            return;
+        break;
+
+    case 'c': // toggle stopping on cycles
+        g->flags = g->flags & CYCLE_STOP ? g->flags & ~(CYCLE_STOP) : g->flags | CYCLE_STOP;
+        return;
+        break;
+
+    case 'b': /* toggle cache-blocked stepping. Generations are only tiled in time when
+                 several are computed at once (jumps), a single 'n' is a plain row pass */
+        g->flags = g->flags & BLOCKED_STEP ? g->flags & ~(BLOCKED_STEP) : g->flags | BLOCKED_STEP;
+        return;
+        break;
+
+    case 'p': // toggle profiling and its overlay
+        if (g->profile)
+            g->profile->enabled = !g->profile->enabled;
+        return;
+        break;
+
+    case 'j': // jump to the generation typed in the input field, or cancel a running jump
+        if (g->flags & NORMAL && g->inputn)
+        {
+            g->jump_target = strtoull(g->inputfield, NULL, 10);
+            g->inputn = 0;
+            for (size_t i = 0; i < sizeof(g->inputfield); ++i)
+                g->inputfield[i] = 0;
+            continue_jump(g);
+        }
+        else
+        {
+            g->jump_target = 0;
+        }
+        return;
+        break;
+
+    case ERR: // no input this frame, keep a long jump going
+        if (g->jump_target)
+            continue_jump(g);
+        return;
         break;
 
     case 'd': // toggle debug
@@ -62,9 +399,11 @@ GAME_UPDATE(game_update)
     case '7':
     case '8':
     case '9':
-        // If we are on the menu, record numerical input
-        if (g->flags & GIT_MENU && g->inputn < sizeof(g->inputfield))
+        // Record numerical input, either a commit # on the menu or a generation to jump to
+        if (g->inputn < sizeof(g->inputfield) - 1)
             g->inputfield[g->inputn++] = g->input;
+        if (g->flags & NORMAL)
+            return;
         break;
 
     case KEY_ENTER:
@@ -100,8 +439,10 @@ GAME_UPDATE(game_update)
     case KEY_BACKSPACE:
     case KEY_DC:
     case KEY_DL:
-        // If we are on the menu, erase 1 character from input
-        if (g->flags & GIT_MENU && g->inputn)
+    case 127:  // raw() mode gets DEL/^H from many terminals instead of KEY_BACKSPACE
+    case '\b':
+        // Erase 1 character from input, either a commit # or a generation to jump to
+        if (g->inputn)
         {
             g->inputfield[--g->inputn] = 0;
         }
@@ -114,39 +455,7 @@ GAME_UPDATE(game_update)
     
     if (g->flags & NORMAL)
     {
-        for (int i = 0; i < g->height; ++i)
-            for (int j = 0; j < g->width; ++j)
-            {
-                int neighbours = count_neighbours(j, i, g->board, g->width, g->height);
-                if (g->board[i*g->width+j] == 'X') // currently alive
-                {
-                    if (neighbours == 2 || neighbours == 3)
-                    {
-                        // Live
-                        g->aux_board[i*g->width+j] = 'X';
-                    }
-                    else
-                    {
-                        // Die
-                        g->aux_board[i*g->width+j] = ' ';
-                    }
-                }
-                else
-                {
-                    // Currently dead                    
-                    if (neighbours == 3)
-                    {
-                        // Live
-                        g->aux_board[i*g->width+j] = 'X';
-                    }
-                    else
-                    {
-                        // Die
-                        g->aux_board[i*g->width+j] = ' ';
-                    }
-                }
-            }
-        memcpy(g->board, g->aux_board, g->width*g->height);
+        advance(g, 1);
     }
     else if (g->flags & GIT_MENU)
     {
@@ -154,6 +463,36 @@ GAME_UPDATE(game_update)
     }
 }
 
+/* Draws the per-phase timings on top of the board. The histogram column shows
+   durations from 1us to ~1s on a log2 scale, denser glyphs meaning more samples. */
+static void render_profile(game_state_t *g)
+{
+    static const char glyphs[] = " .:-=+*#%@";
+    profile_t *p = g->profile;
+
+    wattrset(g->window, A_REVERSE);
+    mvwprintw(g->window, 0, 0, "%-16s %8s %10s %10s %10s  %-20s",
+              "PHASE", "COUNT", "LAST(us)", "AVG(us)", "MAX(us)", "HISTOGRAM 1us..1s");
+    for (int i = 0; i < PROFILE_PHASE_COUNT; ++i)
+    {
+        profile_phase_stats_t *stats = &p->phases[i];
+        uint64_t count = stats->count;
+        mvwprintw(g->window, i+1, 0, "%-16s %8lu %10.1f %10.1f %10.1f  ",
+                  profile_phase_names[i], (unsigned long) count,
+                  stats->last_ns / 1000.0,
+                  count ? stats->total_ns / 1000.0 / count : 0.0,
+                  stats->max_ns / 1000.0);
+
+        uint64_t max_bucket = 1;
+        for (int b = 10; b < 30; ++b)
+            if (stats->histogram[b] > max_bucket)
+                max_bucket = stats->histogram[b];
+        for (int b = 10; b < 30; ++b)
+            waddch(g->window, glyphs[stats->histogram[b] * (sizeof(glyphs) - 2) / max_bucket]);
+    }
+    wattroff(g->window, A_REVERSE);
+}
+
 GAME_RENDER(game_render)
 {
     wclear(g->window);
@@ -178,6 +517,24 @@ GAME_RENDER(game_render)
             }
         }
         //wattroff(g->window, A_BOLD);
+
+        if (g->profile && g->profile->enabled)
+            render_profile(g);
+
+        // Show the generation being typed, it is only drawn in the menu otherwise
+        if (g->inputn)
+        {
+            wattrset(g->window, A_REVERSE);
+            mvwprintw(g->window, g->height - 1, 0, "JUMP TO GENERATION: %s (j to go)", g->inputfield);
+            wattroff(g->window, A_REVERSE);
+        }
+        else if (g->jump_target)
+        {
+            wattrset(g->window, A_REVERSE);
+            mvwprintw(g->window, g->height - 1, 0, "JUMPING TO GENERATION %lu, AT %lu (j to cancel)",
+                      (unsigned long) g->jump_target, (unsigned long) g->generation);
+            wattroff(g->window, A_REVERSE);
+        }
     }
     else
     {
@@ -270,4 +627,7 @@ GAME_RESET(game_reset)
 
     g->board[i] = '\0';
     g->aux_board[i] = '\0';
+
+    g->generation = 0;
+    reset_generation_tracking(g);
 }
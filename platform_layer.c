@@ -1,11 +1,15 @@
 #define _GNU_SOURCE
 #include <stdio.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <limits.h>
 #include <errno.h>
 #include <time.h>
+#include <signal.h>
 #include <fcntl.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
 #include <link.h>
 #include <dlfcn.h>
 
@@ -15,6 +19,9 @@
 void delete_temp_dirs()
 {
     int pid = fork();
+    if (pid < 0)
+        return;
+
     if (!pid)
     {
         // Redirect output to /dev/null to avoid messing the screen
@@ -28,7 +35,7 @@ void delete_temp_dirs()
         }
     }
     // Wait for removal to finish
-    wait(0);
+    waitpid(pid, NULL, 0);
 }
 
 // Buffer to allocate the returned string in the function below
@@ -168,6 +175,362 @@ int read_git_repo(git_repository *repo, commit_node_t **list_head)
     return 1;
 }
 
+// Instrumentation shared with the game code through game_state.profile
+profile_t profile;
+
+/* Writes every event still in the profiling ring as Chrome trace JSON, loadable from
+   chrome://tracing or Perfetto.
+
+   Returns 1 on success, 0 on error
+ */
+int export_trace(profile_t *p, char *filename)
+{
+    FILE *fp = fopen(filename, "w");
+    if (!fp)
+        return 0;
+
+    uint64_t head = __atomic_load_n(&p->ring_head, __ATOMIC_ACQUIRE);
+    uint64_t first = head > PROFILE_RING_SIZE ? head - PROFILE_RING_SIZE : 0;
+
+    fprintf(fp, "{\"traceEvents\":[");
+    for (uint64_t i = first; i < head; ++i)
+    {
+        profile_event_t *event = &p->ring[i & (PROFILE_RING_SIZE - 1)];
+        fprintf(fp, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                i == first ? "" : ",", profile_phase_names[event->phase],
+                event->start_ns / 1000.0, event->duration_ns / 1000.0);
+    }
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(fp);
+    return 1;
+}
+
+/* Distributed stepping. The board rows are split in slabs, one per worker process.
+   Every generation each worker swaps its edge rows with its neighbours over a Unix
+   socket pair and steps its slab with the game code's game_step_slab. The coordinator
+   (us) acts as a global barrier by waiting for every worker's hash and population
+   before starting the next generation, and gathers the slabs back into the board at
+   the end of each batch so the rest of the code never notices.
+
+   This spreads the stepping over more cores, not the memory: the coordinator still
+   holds the whole board (plus aux_board as a gather buffer), so boards are still
+   limited by what fits in a single process.
+
+   If any worker fails, all of them are stopped and the game steps in-process again
+   from the last board gathered. */
+
+#define MAX_WORKERS 64
+
+typedef enum {
+    WORKER_LOAD,   // followed by the slab contents
+    WORKER_STEP,   // answered with the slab hash and population
+    WORKER_GATHER, // answered with the slab contents
+    WORKER_QUIT
+} worker_command_t;
+
+typedef struct {
+    int count;
+    pid_t pids[MAX_WORKERS];
+    int sockets[MAX_WORKERS];
+    int first_row[MAX_WORKERS+1]; // worker i owns rows [first_row[i], first_row[i+1])
+    char error[64];               // why the workers were stopped, if they failed
+} workers_t;
+
+workers_t workers;
+
+// Blocking helpers that survive short reads/writes. Return 1 on success, 0 on error
+int write_all(int fd, const void *buffer, size_t size)
+{
+    const uint8_t *p = buffer;
+    while (size)
+    {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        p += n;
+        size -= n;
+    }
+    return 1;
+}
+
+int read_all(int fd, void *buffer, size_t size)
+{
+    uint8_t *p = buffer;
+    while (size)
+    {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        p += n;
+        size -= n;
+    }
+    return 1;
+}
+
+/* Swaps edge rows with the neighbouring slabs. Even workers send first and odd ones
+   receive first, so rows bigger than the socket buffers can't deadlock the chain. */
+int exchange_halos(int index, int up, int down, uint8_t *slab, int rows, int width)
+{
+    uint8_t *halo_above = slab;
+    uint8_t *first = slab + width;
+    uint8_t *last = slab + (size_t)rows * width;
+    uint8_t *halo_below = slab + (size_t)(rows+1) * width;
+
+    if (index % 2 == 0)
+    {
+        if (up >= 0 && !write_all(up, first, width)) return 0;
+        if (down >= 0 && !write_all(down, last, width)) return 0;
+        if (up >= 0 && !read_all(up, halo_above, width)) return 0;
+        if (down >= 0 && !read_all(down, halo_below, width)) return 0;
+    }
+    else
+    {
+        if (up >= 0 && !read_all(up, halo_above, width)) return 0;
+        if (down >= 0 && !read_all(down, halo_below, width)) return 0;
+        if (up >= 0 && !write_all(up, first, width)) return 0;
+        if (down >= 0 && !write_all(down, last, width)) return 0;
+    }
+    return 1;
+}
+
+void worker_loop(int index, int coordinator, int up, int down, int first_row, int rows, int width)
+{
+    // Slabs carry a halo row on each side
+    uint8_t *slab = (uint8_t *) calloc((size_t)(rows+2) * width, 1);
+    uint8_t *next = (uint8_t *) calloc((size_t)(rows+2) * width, 1);
+
+    for (;;)
+    {
+        int32_t command;
+        if (!read_all(coordinator, &command, sizeof(command)))
+            _exit(1);
+
+        switch (command)
+        {
+        case WORKER_LOAD:
+            if (!read_all(coordinator, slab + width, (size_t)rows * width))
+                _exit(1);
+            break;
+        case WORKER_STEP:
+        {
+            if (!exchange_halos(index, up, down, slab, rows, width))
+                _exit(1);
+
+            uint64_t result[2] = { 0, 0 }; // hash, population
+            game_code.game_step_slab(next + width, slab, rows, width, up >= 0, down >= 0,
+                                     (uint64_t)first_row * width, &result[0], &result[1]);
+            uint8_t *swap = slab;
+            slab = next;
+            next = swap;
+
+            if (!write_all(coordinator, result, sizeof(result)))
+                _exit(1);
+            break;
+        }
+        case WORKER_GATHER:
+            if (!write_all(coordinator, slab + width, (size_t)rows * width))
+                _exit(1);
+            break;
+        default:
+            _exit(0);
+        }
+    }
+}
+
+void workers_stop(workers_t *w)
+{
+    int32_t command = WORKER_QUIT;
+    for (int i = 0; i < w->count; ++i)
+    {
+        write_all(w->sockets[i], &command, sizeof(command));
+        close(w->sockets[i]);
+        waitpid(w->pids[i], NULL, 0);
+    }
+    w->count = 0;
+}
+
+/* Forks count workers splitting a board of the given size between them.
+   Returns 1 on success, 0 on error (with errno set and no worker left running) */
+int workers_start(workers_t *w, int count, int width, int height)
+{
+    if (count > MAX_WORKERS)
+        count = MAX_WORKERS;
+    if (count > height)
+        count = height;
+
+    int coordinator_sockets[MAX_WORKERS][2];
+    int link_sockets[MAX_WORKERS][2]; // link i joins worker i (end 0) and worker i+1 (end 1)
+
+    for (int i = 0; i < count; ++i)
+    {
+        coordinator_sockets[i][0] = coordinator_sockets[i][1] = -1;
+        link_sockets[i][0] = link_sockets[i][1] = -1;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, coordinator_sockets[i]) ||
+            (i < count-1 && socketpair(AF_UNIX, SOCK_STREAM, 0, link_sockets[i])))
+        {
+            int error = errno;
+            for (int j = 0; j <= i; ++j)
+            {
+                close(coordinator_sockets[j][0]);
+                close(coordinator_sockets[j][1]);
+                close(link_sockets[j][0]);
+                close(link_sockets[j][1]);
+            }
+            errno = error;
+            return 0;
+        }
+        w->first_row[i] = (int)((int64_t)height * i / count);
+    }
+    w->first_row[count] = height;
+
+    for (int i = 0; i < count; ++i)
+    {
+        int pid = fork();
+        if (pid < 0)
+        {
+            /* Out of processes. Keep the sockets of the workers already running so
+               workers_stop() can tell them to quit, and drop everything else */
+            int error = errno;
+            for (int j = 0; j < count; ++j)
+            {
+                close(coordinator_sockets[j][1]);
+                if (j < i)
+                    w->sockets[j] = coordinator_sockets[j][0];
+                else
+                    close(coordinator_sockets[j][0]);
+                if (j < count-1)
+                {
+                    close(link_sockets[j][0]);
+                    close(link_sockets[j][1]);
+                }
+            }
+            w->count = i;
+            workers_stop(w);
+            errno = error;
+            return 0;
+        }
+        if (!pid) // we are the worker
+        {
+            int up = i > 0 ? link_sockets[i-1][1] : -1;
+            int down = i < count-1 ? link_sockets[i][0] : -1;
+
+            // Keep only the sockets this worker talks through
+            for (int j = 0; j < count; ++j)
+            {
+                close(coordinator_sockets[j][0]);
+                if (j != i)
+                    close(coordinator_sockets[j][1]);
+                if (j < count-1)
+                {
+                    if (link_sockets[j][0] != down)
+                        close(link_sockets[j][0]);
+                    if (link_sockets[j][1] != up)
+                        close(link_sockets[j][1]);
+                }
+            }
+
+            worker_loop(i, coordinator_sockets[i][1], up, down,
+                        w->first_row[i], w->first_row[i+1] - w->first_row[i], width);
+        }
+        w->pids[i] = pid;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        close(coordinator_sockets[i][1]);
+        w->sockets[i] = coordinator_sockets[i][0];
+        if (i < count-1)
+        {
+            close(link_sockets[i][0]);
+            close(link_sockets[i][1]);
+        }
+    }
+    w->count = count;
+    return 1;
+}
+
+/* Tears the workers down after a communication error and goes back to stepping
+   in-process. The reason is kept for the debug info. */
+void workers_fail(workers_t *w, char *what)
+{
+    snprintf(w->error, sizeof(w->error), "%s: %s", what, errno ? strerror(errno) : "worker died");
+
+    // Some of them may be blocked on a dead neighbour, don't wait for a clean quit
+    for (int i = 0; i < w->count; ++i)
+        kill(w->pids[i], SIGKILL);
+    workers_stop(w);
+
+    game_state.platform_step = NULL;
+}
+
+/* Sends the current board to the workers, needed whenever it changes outside of a step.
+   Returns 1 on success, 0 on error (the workers are stopped) */
+int workers_load(workers_t *w, uint8_t *board, int width)
+{
+    int32_t command = WORKER_LOAD;
+    for (int i = 0; i < w->count; ++i)
+    {
+        errno = 0;
+        if (!write_all(w->sockets[i], &command, sizeof(command)) ||
+            !write_all(w->sockets[i], board + (size_t)w->first_row[i] * width,
+                       (size_t)(w->first_row[i+1] - w->first_row[i]) * width))
+        {
+            workers_fail(w, "load");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+PLATFORM_STEP(workers_step)
+{
+    int32_t command = WORKER_STEP;
+    errno = 0;
+    for (int t = 0; t < generations; ++t)
+    {
+        for (int i = 0; i < workers.count; ++i)
+        {
+            if (!write_all(workers.sockets[i], &command, sizeof(command)))
+                goto fail;
+        }
+
+        hashes[t] = 0;
+        populations[t] = 0;
+        for (int i = 0; i < workers.count; ++i)
+        {
+            uint64_t result[2];
+            if (!read_all(workers.sockets[i], result, sizeof(result)))
+                goto fail;
+            hashes[t] ^= result[0];
+            populations[t] += result[1];
+        }
+    }
+
+    // Gather into aux_board first so a failure halfway leaves the board as it was
+    command = WORKER_GATHER;
+    for (int i = 0; i < workers.count; ++i)
+    {
+        if (!write_all(workers.sockets[i], &command, sizeof(command)) ||
+            !read_all(workers.sockets[i], g->aux_board + (size_t)workers.first_row[i] * g->width,
+                      (size_t)(workers.first_row[i+1] - workers.first_row[i]) * g->width))
+            goto fail;
+    }
+    memcpy(g->board, g->aux_board, (size_t)g->width * g->height);
+    return 1;
+
+fail:
+    workers_fail(&workers, "step");
+    return 0;
+}
+
 void clean_and_exit(int exit_code)
 {
     // Restore terminal defaults on exit
@@ -222,14 +585,225 @@ void *load_functions(game_code_t *code, char *filename)
         {
             code->game_reset = game_reset;
         }
+
+        // Older versions of the game code don't have it, we just can't distribute those
+        code->game_step_slab = (game_step_slab_f *) dlsym(library_handle, "game_step_slab");
+        dlerror();
+
         return library_handle;
     }
 }
 
-int main()
+/* Creates the shared memory segment viewers attach to. It refuses to reuse an existing
+   one, as that would hijack another instance's viewers (or it is a leftover from a
+   crash, which has to be removed from /dev/shm by hand).
+
+   Returns NULL on error, with errno set */
+shared_board_t *shared_board_create(int width, int height)
+{
+    size_t size = sizeof(shared_board_t) + (size_t)width * height;
+
+    int fd = shm_open(SHARED_BOARD_NAME, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        return NULL;
+
+    shared_board_t *shared = MAP_FAILED;
+    if (!ftruncate(fd, size))
+        shared = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (shared == MAP_FAILED)
+    {
+        int error = errno;
+        close(fd);
+        shm_unlink(SHARED_BOARD_NAME);
+        errno = error;
+        return NULL;
+    }
+    close(fd);
+
+    shared->height = height;
+    shared->width = width;
+    shared->sequence = 0;
+    __atomic_store_n(&shared->magic, SHARED_BOARD_MAGIC, __ATOMIC_RELEASE);
+    return shared;
+}
+
+void shared_board_destroy(shared_board_t *shared)
+{
+    munmap(shared, sizeof(shared_board_t) + (size_t)shared->width * shared->height);
+    shm_unlink(SHARED_BOARD_NAME);
+}
+
+// Seqlock write side, never waits on readers
+void shared_board_publish(shared_board_t *shared, game_state_t *g)
+{
+    if (!shared)
+        return;
+
+    uint64_t sequence = shared->sequence;
+    __atomic_store_n(&shared->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(shared->board, g->board, (size_t)g->width * g->height);
+    shared->generation = g->generation;
+    shared->population = g->population;
+
+    __atomic_store_n(&shared->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+/* Starts the workers if they were asked for and the loaded game code can run them,
+   handing them the current board */
+void setup_workers(int count)
+{
+    game_state.platform_step = NULL;
+    if (count <= 0 || !game_code.game_step_slab)
+        return;
+
+    if (!workers_start(&workers, count, game_state.width, game_state.height))
+    {
+        snprintf(workers.error, sizeof(workers.error), "start: %s", strerror(errno));
+        return;
+    }
+
+    if (workers_load(&workers, game_state.board, game_state.width))
+        game_state.platform_step = workers_step;
+}
+
+/** Self-check **/
+
+// Returns 1 if both states hold the same board and generation tracking
+int same_state(game_state_t *a, game_state_t *b, int compare_history)
+{
+    return !memcmp(a->board, b->board, (size_t)a->width * a->height) &&
+        a->generation == b->generation &&
+        a->population == b->population &&
+        a->period == b->period &&
+        (!compare_history || !memcmp(a->hash_history, b->hash_history, sizeof(a->hash_history)));
+}
+
+// Drives a 'j' jump through game_update like the main loop would, until it lands
+void verify_jump(game_state_t *g, uint64_t target)
+{
+    g->inputn = snprintf(g->inputfield, sizeof(g->inputfield), "%" PRIu64, target);
+    g->input = 'j';
+    game_code.game_update(g);
+    while (g->jump_target)
+    {
+        g->input = ERR;
+        game_code.game_update(g);
+    }
+}
+
+/* Headless check for `make check`. Steps random boards of assorted shapes with the
+   reference stepper and, on game_state, with the cache-blocked stepper and then (if
+   worker_count > 0) with that many worker processes. Checks they agree bit for bit
+   after every 'n' and after a couple of jumps (which is where the blocked stepper
+   tiles several generations at once).
+   Returns 1 if everything matched */
+int verify_engine(int worker_count)
+{
+    int sizes[][2] = { {1, 1}, {3, 7}, {24, 80}, {57, 33}, {300, 1000}, {16, 100000} };
+    int all_ok = 1;
+
+    for (int mode = 0; mode < (worker_count > 0 ? 2 : 1); ++mode)
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        for (int seed = 0; seed < 2; ++seed)
+        {
+            int h = sizes[s][0];
+            int w = sizes[s][1];
+
+            game_state_t reference = { 0 };
+            reference.height = game_state.height = h;
+            reference.width = game_state.width = w;
+            reference.flags = NORMAL;
+            game_state.flags = mode ? NORMAL : NORMAL | BLOCKED_STEP;
+            reference.board = (uint8_t*) calloc(sizeof(uint8_t), h*w + 1);
+            reference.aux_board = (uint8_t*) calloc(sizeof(uint8_t), h*w + 1);
+            game_state.board = (uint8_t*) calloc(sizeof(uint8_t), h*w + 1);
+            game_state.aux_board = (uint8_t*) calloc(sizeof(uint8_t), h*w + 1);
+
+            srand(seed);
+            game_code.game_reset(&reference);
+            srand(seed);
+            game_code.game_reset(&game_state);
+
+            char *failure = NULL;
+            if (mode)
+            {
+                setup_workers(worker_count);
+                if (!game_state.platform_step)
+                    failure = "could not start workers";
+            }
+
+            for (int n = 0; n < 20 && !failure; ++n)
+            {
+                reference.input = game_state.input = 'n';
+                game_code.game_update(&reference);
+                game_code.game_update(&game_state);
+                if (!same_state(&reference, &game_state, 1))
+                    failure = "mismatch after 'n'";
+            }
+
+            /* Only board and counters: the blocked jump batches generations before the
+               cycle is found, so its hash history gets remapped from a later point */
+            uint64_t targets[] = { 100, 250 };
+            for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]) && !failure; ++t)
+            {
+                verify_jump(&reference, targets[t]);
+                verify_jump(&game_state, targets[t]);
+                if (!same_state(&reference, &game_state, 0))
+                    failure = "mismatch after 'j'";
+            }
+
+            printf("%-10s %6dx%-6d seed %d: %s%s\n", mode ? "workers" : "blocked", h, w, seed,
+                   failure ? "FAILED: " : "ok", failure ? failure : "");
+            all_ok = all_ok && !failure;
+
+            workers_stop(&workers);
+            game_state.platform_step = NULL;
+
+            free(reference.board);
+            free(reference.aux_board);
+            free(game_state.board);
+            free(game_state.aux_board);
+        }
+    }
+    return all_ok;
+}
+
+int main(int argc, char **argv)
 {
     /** Initialization **/
 
+    /* Number of worker processes to spread the stepping across, 0 to step it ourselves.
+       The board is still held whole by this process, see workers_step() */
+    int worker_count = 0;
+    // Whether to publish the board for viewer processes
+    int share = 0;
+    shared_board_t *shared = NULL;
+    // Run the self-check instead of the game
+    int verify = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--workers") && i+1 < argc)
+            worker_count = strtol(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--share"))
+            share = 1;
+        else if (!strcmp(argv[i], "--verify"))
+            verify = 1;
+    }
+
+    // A dead worker must show up as a failed write, not kill us
+    signal(SIGPIPE, SIG_IGN);
+
+    if (verify)
+    {
+        if (!load_functions(&game_code, "./game.so"))
+            return 1;
+        return verify_engine(worker_count) ? 0 : 1;
+    }
+
     // Initialize libgit2
     git_libgit2_init();
     
@@ -248,8 +822,14 @@ int main()
     game_state.platform_oid = game_state.commit_list->oid;
     game_state.game_oid = game_state.commit_list->oid;
 
+    // Profiling can be turned on from the start to also time the first load
+    profile.enabled = getenv("PROFILE") != NULL;
+    game_state.profile = &profile;
+
     // Inject platform-independent code
+    uint64_t profile_start = profile_begin(&profile);
     void *game_handle = load_functions(&game_code, "./game.so");
+    profile_end(&profile, PROFILE_LOAD_FUNCTIONS, profile_start);
     if (!game_handle)
         goto cleanup;
 
@@ -289,11 +869,25 @@ int main()
     // Reset game state
     game_code.game_reset(&game_state);
 
+    setup_workers(worker_count);
+
+    if (share && !(shared = shared_board_create(w, h)))
+    {
+        int error = errno;
+        endwin();
+        fprintf(stderr, "Error creating shared board %s: %s\n", SHARED_BOARD_NAME, strerror(error));
+        goto cleanup;
+    }
+    shared_board_publish(shared, &game_state);
+
     // Initiate flags
     game_state.flags = NORMAL;
 
-    char debuginfo[128];
+    char debuginfo[256];
     game_state.debuginfo = debuginfo;
+
+    // Why the last attempt to load a different commit failed, if it did
+    char reload_error[64] = "";
     
     /** Main loop **/
     for (;;)
@@ -301,16 +895,28 @@ int main()
         // Fill debug info
         struct link_map *linkmap;        
         dlinfo(game_handle, RTLD_DI_LINKMAP, &linkmap);
-        snprintf(debuginfo, sizeof(debuginfo), "CODE PATH: %s", linkmap->l_name);
+        snprintf(debuginfo, sizeof(debuginfo), "CODE PATH: %s  GEN: %" PRIu64 "  POP: %" PRIu64 "  PERIOD: %" PRId32 "  WORKERS: %d %s %s",
+                 linkmap->l_name, game_state.generation, game_state.population, game_state.period,
+                 workers.count, workers.error, reload_error);
         
         
         // Check if user wants to load a different commit for the game runtime
         if (memcmp((const void *)&game_state.selected_oid, (const void *)&empty_oid, GIT_OID_RAWSZ))
         {
             // Copy entire commit tree to temp folder
+            profile_start = profile_begin(&profile);
             char *tempdir = dump_git_tree("tempXXXXXX", game_state.selected_oid, game_state.repo);
+            profile_end(&profile, PROFILE_DUMP_GIT_TREE, profile_start);
 
+            profile_start = profile_begin(&profile);
             int pid = fork();
+            if (pid < 0)
+            {
+                // Can't build it, stay on the current code
+                snprintf(reload_error, sizeof(reload_error), "RELOAD FAILED: %s", strerror(errno));
+                game_state.selected_oid = empty_oid;
+                continue;
+            }
 
             if (!pid) // we are the child process
             {
@@ -331,7 +937,8 @@ int main()
                 }
             }
             // Wait for compilation to finish
-            wait(0);
+            waitpid(pid, NULL, 0);
+            profile_end(&profile, PROFILE_MAKE, profile_start);
             
             // Record change of runtime
             game_state.game_oid = game_state.selected_oid;
@@ -355,10 +962,19 @@ int main()
             strcat(libpath, tempdir);
             strcat(libpath, "/game.so");
 
+            profile_start = profile_begin(&profile);
             game_handle = load_functions(&game_code, libpath);
+            profile_end(&profile, PROFILE_LOAD_FUNCTIONS, profile_start);
             if (!game_handle)
                 goto cleanup;
 
+            /* Cycles found by the previous code don't hold for new rules, and older
+               game code steps the board without tracking generations at all */
+            reset_generation_tracking(&game_state);
+
+            // Workers still run the previous code, restart them with the new one
+            workers_stop(&workers);
+            setup_workers(worker_count);
 
             // Re-render in case the rendering function has changed
             //game_code.game_render(&game_state);
@@ -371,7 +987,23 @@ int main()
         switch (ch)
         {
         case ERR:
-            usleep(16*1000);
+            if (game_state.jump_target)
+            {
+                // The game code is in the middle of a long jump, give it this frame
+                game_state.input = ERR;
+                profile_start = profile_begin(&profile);
+                game_code.game_update(&game_state);
+                profile_end(&profile, PROFILE_GAME_UPDATE, profile_start);
+                shared_board_publish(shared, &game_state);
+
+                profile_start = profile_begin(&profile);
+                game_code.game_render(&game_state);
+                profile_end(&profile, PROFILE_GAME_RENDER, profile_start);
+            }
+            else
+            {
+                usleep(16*1000);
+            }
             //game_code.game_render(&game_state);
             break;
         case 'q':
@@ -379,12 +1011,25 @@ int main()
             break;
         case 'r':
             game_code.game_reset(&game_state);
+            workers_load(&workers, game_state.board, game_state.width);
+            shared_board_publish(shared, &game_state);
+            profile_start = profile_begin(&profile);
             game_code.game_render(&game_state);
+            profile_end(&profile, PROFILE_GAME_RENDER, profile_start);
+            break;
+        case 't':
+            export_trace(&profile, "trace.json");
             break;
         default:
             game_state.input = ch;
+            profile_start = profile_begin(&profile);
             game_code.game_update(&game_state);
+            profile_end(&profile, PROFILE_GAME_UPDATE, profile_start);
+            shared_board_publish(shared, &game_state);
+
+            profile_start = profile_begin(&profile);
             game_code.game_render(&game_state);
+            profile_end(&profile, PROFILE_GAME_RENDER, profile_start);
             break;
         }
     }
@@ -393,6 +1038,10 @@ int main()
 cleanup:
     // Restore terminal defaults on exit
     
+    workers_stop(&workers);
+    if (shared)
+        shared_board_destroy(shared);
+
     // Clean unneeded files
     delete_temp_dirs();
     endwin();
@@ -0,0 +1,200 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common.h"
+
+/* Read-only viewer for a board published by `platform_layer --share`. It maps the
+   shared segment without write access and renders its own viewport at its own
+   frame rate, so any number of viewers can watch without slowing the simulation. */
+
+/* Attaches to the shared board, read-only.
+   Returns NULL on error */
+shared_board_t *shared_board_attach()
+{
+    int fd = shm_open(SHARED_BOARD_NAME, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+
+    // The segment may still be empty if the publisher has not sized it yet
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(shared_board_t))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // Map the header first to learn the board dimensions
+    shared_board_t *header = mmap(NULL, sizeof(shared_board_t), PROT_READ, MAP_SHARED, fd, 0);
+    if (header == MAP_FAILED)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHARED_BOARD_MAGIC)
+    {
+        munmap(header, sizeof(shared_board_t));
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = sizeof(shared_board_t) + (size_t)header->width * header->height;
+    munmap(header, sizeof(shared_board_t));
+
+    // A board larger than the segment would fault on the first read past its end
+    if ((size_t)st.st_size < size)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    shared_board_t *shared = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return shared == MAP_FAILED ? NULL : shared;
+}
+
+/* Seqlock read side. Copies the rows of the viewport into snapshot (a rows x cols
+   buffer) and retries if the writer published a new board meanwhile. Retries back off
+   exponentially so that a writer copying a large board gets the time to finish.
+   Returns 1 if the snapshot is consistent, 0 if the writer kept us out this frame */
+int shared_board_read(shared_board_t *shared, uint8_t *snapshot, int top, int left, int rows, int cols,
+                      uint64_t *generation, uint64_t *population)
+{
+    struct timespec backoff = { .tv_sec = 0, .tv_nsec = 50*1000 };
+
+    for (int attempt = 0; attempt < 16; ++attempt)
+    {
+        if (attempt)
+        {
+            nanosleep(&backoff, NULL);
+            if (backoff.tv_nsec < 4*1000*1000)
+                backoff.tv_nsec *= 2;
+        }
+
+        uint64_t sequence = __atomic_load_n(&shared->sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1) // writer is in the middle of a copy
+            continue;
+
+        for (int i = 0; i < rows; ++i)
+            memcpy(snapshot + (size_t)i * cols, shared->board + (size_t)(top+i) * shared->width + left, cols);
+        *generation = shared->generation;
+        *population = shared->population;
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shared->sequence, __ATOMIC_RELAXED) == sequence)
+            return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    /** Initialization **/
+
+    int fps = 30;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--fps") && i+1 < argc)
+            fps = strtol(argv[++i], NULL, 10);
+    }
+    if (fps < 1)
+        fps = 1;
+
+    shared_board_t *shared = shared_board_attach();
+    if (!shared)
+    {
+        fprintf(stderr, "Error attaching to the shared board, is platform_layer running with --share?\n");
+        exit(1);
+    }
+
+    initscr();
+    raw();
+    noecho();
+    nonl();
+    curs_set(0);
+
+    int h, w;
+    getmaxyx(stdscr, h, w);
+
+    WINDOW *window = newwin(h, w, 0, 0);
+    nodelay(window, TRUE);
+    keypad(window, TRUE);
+
+    // Last line is kept for the status bar
+    int rows = h - 1 < shared->height ? h - 1 : shared->height;
+    int cols = w < shared->width ? w : shared->width;
+    uint8_t *snapshot = (uint8_t *) calloc((size_t)rows * cols, 1);
+    memset(snapshot, ' ', (size_t)rows * cols);
+
+    int top = 0;
+    int left = 0;
+    uint64_t generation = 0;
+    uint64_t population = 0;
+
+    /** Main loop **/
+    for (;;)
+    {
+        int ch;
+        while ((ch = wgetch(window)) != ERR)
+        {
+            switch (ch)
+            {
+            case 'q':
+                goto cleanup;
+            case KEY_UP:
+            case 'k':
+                --top;
+                break;
+            case KEY_DOWN:
+            case 'j':
+                ++top;
+                break;
+            case KEY_LEFT:
+            case 'h':
+                --left;
+                break;
+            case KEY_RIGHT:
+            case 'l':
+                ++left;
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Keep the viewport inside the board
+        if (top > shared->height - rows)
+            top = shared->height - rows;
+        if (top < 0)
+            top = 0;
+        if (left > shared->width - cols)
+            left = shared->width - cols;
+        if (left < 0)
+            left = 0;
+
+        // On a failed read we just show the previous frame again
+        shared_board_read(shared, snapshot, top, left, rows, cols, &generation, &population);
+
+        for (int i = 0; i < rows; ++i)
+            mvwaddnstr(window, i, 0, (const char *) snapshot + (size_t)i * cols, cols);
+
+        wattrset(window, A_REVERSE);
+        mvwprintw(window, h - 1, 0, "GEN: %lu  POP: %lu  VIEW: %d,%d of %dx%d  (arrows/hjkl to move, q to quit)",
+                  (unsigned long) generation, (unsigned long) population, top, left, shared->height, shared->width);
+        wclrtoeol(window);
+        wattroff(window, A_REVERSE);
+        wrefresh(window);
+
+        usleep(1000000 / fps);
+    }
+
+    /** Cleanup **/
+cleanup:
+    endwin();
+    return 0;
+}